@@ -15,7 +15,7 @@ rm -f pipe_* 2>/dev/null
 
 echo ""
 echo "=== Iniciando controlador ==="
-./bin/controlador -i 8 -f 19 -s 2 -t 50 -p pipe_controlador &
+./bin/controlador -i 8 -f 19 -s 2 -t 50 -p pipe_controlador -m "${MODO:-mutex}" -w "${TRABAJADORES:-1}" &
 CONTROLADOR_PID=$!
 
 sleep 1
@@ -6,6 +6,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <errno.h>
@@ -16,12 +17,33 @@
 #define MAX_AGENTES  64
 #define MAX_NOMBRE   64
 #define MAX_PIPE     128
+#define MAX_TRABAJADORES 16
+#define MAX_COLA     256
+#define CACHE_LINEA  64
+
+// Estados de un slot de reserva. PENDIENTE solo se usa en modo optimista,
+// mientras el hilo que reclamo el slot termina de llenar sus campos.
+#define RESERVA_LIBRE     0u
+#define RESERVA_ACTIVA    1u
+#define RESERVA_PENDIENTE 2u
+
+// En modo optimista `activa` guarda el estado en los 2 bits bajos y una
+// generacion en el resto, que sube cada vez que se reclama el slot. Asi un
+// CAS con la etiqueta vista no toca una reserva posterior en el mismo slot.
+#define ESTADO_SLOT(v)       ((v) & 3u)
+#define CON_ESTADO(v, e)     (((v) & ~3u) | (e))
+#define GENERACION_SLOT      4u
+
+typedef enum {
+    MODO_MUTEX,
+    MODO_OPTIMISTA
+} ModoAdmision;
 
 typedef struct {
     char familia[MAX_NOMBRE];
     int personas;
     int horaInicio; // hora de inicio de la reserva (dura 2 horas)
-    int activa;
+    atomic_uint activa;
 } Reserva;
 
 typedef struct {
@@ -30,13 +52,52 @@ typedef struct {
     int enUso;
 } AgenteInfo;
 
+// Contador por hora del modo optimista, cada uno en su propia linea de cache
+// para que las reservas de horas distintas no se estorben entre si.
+typedef struct {
+    _Alignas(CACHE_LINEA) atomic_int reservadas;
+} HoraAtomica;
+
+// Solicitud REQ ya parseada, en espera de un hilo trabajador. Lleva su propia
+// copia del pipe de respuesta para que los trabajadores no lean `agentes`.
+typedef struct {
+    char pipeRespuesta[MAX_PIPE];
+    char familia[MAX_NOMBRE];
+    int hora;
+    int personas;
+} Solicitud;
+
+// Estado privado de un trabajador en modo optimista: sus estadisticas (se
+// suman al leerlas) y el slot de `reservas` donde empieza a buscar.
+typedef struct {
+    _Alignas(CACHE_LINEA) atomic_int aceptadas;
+    atomic_int reprog;
+    atomic_int negadas;
+    int proximoSlot;
+} ContadoresHilo;
+
 ControlState estado;
 pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
 
 // Estado adicional
 static Reserva reservas[MAX_RESERVAS];
 static AgenteInfo agentes[MAX_AGENTES];
-static int horaActual;
+// Atomico solo para el modo optimista; el modo mutex lo accede con
+// memory_order_relaxed bajo `lock`.
+static atomic_int horaActual;
+static ModoAdmision modo = MODO_MUTEX;
+static int numTrabajadores = 1;
+
+// Cola de solicitudes entre el lector del pipe y los trabajadores
+static Solicitud cola[MAX_COLA];
+static int colaIni, colaLen, colaCerrada;
+static pthread_mutex_t lockCola = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t colaNoVacia = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t colaNoLlena = PTHREAD_COND_INITIALIZER;
+
+// Estado del modo optimista (un slot de contadores por trabajador)
+static HoraAtomica horasAtomicas[HORA_MAX + 1];
+static ContadoresHilo contadoresHilo[MAX_TRABAJADORES];
 
 // Utilidades
 static void error_fatal(const char *msg) {
@@ -47,14 +108,15 @@ static void error_fatal(const char *msg) {
 static void inicializar_estado() {
     for (int h = 0; h <= HORA_MAX; ++h) {
         estado.horas[h].reservadas = 0;
+        atomic_init(&horasAtomicas[h].reservadas, 0);
     }
     for (int i = 0; i < MAX_RESERVAS; ++i) {
-        reservas[i].activa = 0;
+        atomic_init(&reservas[i].activa, RESERVA_LIBRE);
     }
     for (int i = 0; i < MAX_AGENTES; ++i) {
         agentes[i].enUso = 0;
     }
-    horaActual = estado.horaIni;
+    atomic_init(&horaActual, estado.horaIni);
     estado.solicitudes_aceptadas = 0;
     estado.solicitudes_reprog = 0;
     estado.solicitudes_negadas = 0;
@@ -90,10 +152,23 @@ static AgenteInfo *registrar_agente(const char *nombre, const char *pipeResp) {
     return NULL;
 }
 
+// En modo mutex todo acceso a `activa` ocurre bajo `lock`, asi que basta una
+// lectura relajada; en modo optimista el acquire empareja con el release de
+// publicar_reserva antes de leer los demas campos del slot.
+static unsigned leer_slot(int i) {
+    if (modo == MODO_OPTIMISTA)
+        return atomic_load_explicit(&reservas[i].activa, memory_order_acquire);
+    return atomic_load_explicit(&reservas[i].activa, memory_order_relaxed);
+}
+
+static int reserva_activa(int i) {
+    return ESTADO_SLOT(leer_slot(i)) == RESERVA_ACTIVA;
+}
+
 static int ocupacion_en_hora(int hora) {
     int total = 0;
     for (int i = 0; i < MAX_RESERVAS; ++i) {
-        if (reservas[i].activa) {
+        if (reserva_activa(i)) {
             if (hora >= reservas[i].horaInicio &&
                 hora < reservas[i].horaInicio + 2) {
                 total += reservas[i].personas;
@@ -115,8 +190,9 @@ static int hay_cupo_bloque(int horaInicio, int personas) {
 
 static Reserva *crear_reserva(const char *familia, int personas, int horaInicio) {
     for (int i = 0; i < MAX_RESERVAS; ++i) {
-        if (!reservas[i].activa) {
-            reservas[i].activa = 1;
+        if (ESTADO_SLOT(atomic_load_explicit(&reservas[i].activa, memory_order_relaxed)) ==
+            RESERVA_LIBRE) {
+            atomic_store_explicit(&reservas[i].activa, RESERVA_ACTIVA, memory_order_relaxed);
             reservas[i].personas = personas;
             reservas[i].horaInicio = horaInicio;
             strncpy(reservas[i].familia, familia, MAX_NOMBRE - 1);
@@ -148,7 +224,7 @@ static void enviar_respuesta(const char *pipeResp, const char *mensaje) {
 static void procesar_registro(char *agente, char *pipeResp) {
     pthread_mutex_lock(&lock);
     AgenteInfo *info = registrar_agente(agente, pipeResp);
-    int hora = horaActual;
+    int hora = atomic_load_explicit(&horaActual, memory_order_relaxed);
     pthread_mutex_unlock(&lock);
 
     if (!info) {
@@ -163,17 +239,11 @@ static void procesar_registro(char *agente, char *pipeResp) {
            agente, info->pipeRespuesta, hora);
 }
 
-static void procesar_solicitud(char *agente, char *familia, int horaSolic, int personas) {
-    AgenteInfo *info = buscar_agente(agente);
-    if (!info) {
-        fprintf(stderr, "Solicitud de agente no registrado: %s\n", agente);
-        return;
-    }
-
+static void procesar_solicitud(const char *pipeResp, char *familia, int horaSolic, int personas) {
     char respuesta[256];
 
     pthread_mutex_lock(&lock);
-    int horaAct = horaActual;
+    int horaAct = atomic_load_explicit(&horaActual, memory_order_relaxed);
 
     // Validaciones básicas
     if (personas > estado.aforo) {
@@ -182,7 +252,7 @@ static void procesar_solicitud(char *agente, char *familia, int horaSolic, int p
         snprintf(respuesta, sizeof(respuesta),
                  "RESP|NEGADA_AFORO|%s|%d|%d|Personas > aforo",
                  familia, horaSolic, personas);
-        enviar_respuesta(info->pipeRespuesta, respuesta);
+        enviar_respuesta(pipeResp, respuesta);
         return;
     }
 
@@ -192,7 +262,7 @@ static void procesar_solicitud(char *agente, char *familia, int horaSolic, int p
         snprintf(respuesta, sizeof(respuesta),
                  "RESP|NEGADA_FUERA_RANGO|%s|%d|%d|Hora fuera del rango de simulacion",
                  familia, horaSolic, personas);
-        enviar_respuesta(info->pipeRespuesta, respuesta);
+        enviar_respuesta(pipeResp, respuesta);
         return;
     }
 
@@ -211,7 +281,7 @@ static void procesar_solicitud(char *agente, char *familia, int horaSolic, int p
             snprintf(respuesta, sizeof(respuesta),
                      "RESP|NEGADA_EXTEMPORANEA|%s|%d|%d|No hay cupo posterior",
                      familia, horaSolic, personas);
-            enviar_respuesta(info->pipeRespuesta, respuesta);
+            enviar_respuesta(pipeResp, respuesta);
             return;
         } else {
             crear_reserva(familia, personas, nuevaHora);
@@ -220,7 +290,7 @@ static void procesar_solicitud(char *agente, char *familia, int horaSolic, int p
             snprintf(respuesta, sizeof(respuesta),
                      "RESP|REPROGRAMADA|%s|%d|%d|Reprogramada a %d-%d",
                      familia, horaSolic, personas, nuevaHora, nuevaHora + 2);
-            enviar_respuesta(info->pipeRespuesta, respuesta);
+            enviar_respuesta(pipeResp, respuesta);
             return;
         }
     }
@@ -232,7 +302,7 @@ static void procesar_solicitud(char *agente, char *familia, int horaSolic, int p
         snprintf(respuesta, sizeof(respuesta),
                  "RESP|NEGADA_DIA_COMPLETO|%s|%d|%d|Debe volver otro dia",
                  familia, horaSolic, personas);
-        enviar_respuesta(info->pipeRespuesta, respuesta);
+        enviar_respuesta(pipeResp, respuesta);
         return;
     }
 
@@ -243,7 +313,7 @@ static void procesar_solicitud(char *agente, char *familia, int horaSolic, int p
         snprintf(respuesta, sizeof(respuesta),
                  "RESP|ACEPTADA|%s|%d|%d|Reserva OK %d-%d",
                  familia, horaSolic, personas, horaSolic, horaSolic + 2);
-        enviar_respuesta(info->pipeRespuesta, respuesta);
+        enviar_respuesta(pipeResp, respuesta);
         return;
     } else {
         // Buscar otra franja
@@ -260,7 +330,7 @@ static void procesar_solicitud(char *agente, char *familia, int horaSolic, int p
             snprintf(respuesta, sizeof(respuesta),
                      "RESP|NEGADA_SINCUPO|%s|%d|%d|No hay bloques disponibles",
                      familia, horaSolic, personas);
-            enviar_respuesta(info->pipeRespuesta, respuesta);
+            enviar_respuesta(pipeResp, respuesta);
             return;
         } else {
             crear_reserva(familia, personas, nuevaHora);
@@ -269,12 +339,291 @@ static void procesar_solicitud(char *agente, char *familia, int horaSolic, int p
             snprintf(respuesta, sizeof(respuesta),
                      "RESP|REPROGRAMADA|%s|%d|%d|Reprogramada a %d-%d",
                      familia, horaSolic, personas, nuevaHora, nuevaHora + 2);
-            enviar_respuesta(info->pipeRespuesta, respuesta);
+            enviar_respuesta(pipeResp, respuesta);
             return;
         }
     }
 }
 
+// ---------------------------------------------------------------------------
+// Modo optimista: la admision no toma el mutex. Cada hora del bloque se
+// reserva con CAS sobre su contador; si una hora no tiene cupo se deshace lo
+// ya sumado en las anteriores.
+// ---------------------------------------------------------------------------
+
+// Resultado de admitir_optimista
+#define ADMISION_OK          0
+#define ADMISION_SIN_CUPO    1
+#define ADMISION_TABLA_LLENA 2
+#define ADMISION_RELOJ       3 // el reloj avanzo durante la admision; reintentar
+
+static void liberar_horas_optimista(int desde, int hasta, int personas) {
+    for (int h = desde; h < hasta; ++h) {
+        atomic_fetch_sub_explicit(&horasAtomicas[h].reservadas, personas,
+                                  memory_order_relaxed);
+    }
+}
+
+static int reservar_bloque_optimista(int horaInicio, int personas) {
+    if (horaInicio < estado.horaIni || horaInicio + 1 >= estado.horaFin)
+        return 0;
+    for (int h = horaInicio; h < horaInicio + 2; ++h) {
+        atomic_int *contador = &horasAtomicas[h].reservadas;
+        int actual = atomic_load_explicit(contador, memory_order_relaxed);
+        do {
+            if (actual + personas > estado.aforo) {
+                // rollback de las horas ya reservadas
+                liberar_horas_optimista(horaInicio, h, personas);
+                return 0;
+            }
+        } while (!atomic_compare_exchange_weak_explicit(contador, &actual, actual + personas,
+                                                        memory_order_acq_rel,
+                                                        memory_order_relaxed));
+    }
+    return 1;
+}
+
+// Registra la reserva en la tabla (para el hilo del reloj) sin tomar el mutex.
+// La ocupacion ya quedo contabilizada en reservar_bloque_optimista. Cada
+// trabajador recorre la tabla desde su propio indice y solo intenta el CAS
+// sobre slots que una lectura relajada ya vio libres, para no tomar en
+// exclusiva lineas de cache ocupadas. En `etiqueta` deja el valor ACTIVA con
+// la generacion nueva, para que admitir_optimista pueda retirar solo esta.
+static Reserva *publicar_reserva(ContadoresHilo *c, const char *familia, int personas,
+                                 int horaInicio, unsigned *etiqueta) {
+    for (int n = 0; n < MAX_RESERVAS; ++n) {
+        int i = (c->proximoSlot + n) % MAX_RESERVAS;
+        unsigned libre = atomic_load_explicit(&reservas[i].activa, memory_order_relaxed);
+        if (ESTADO_SLOT(libre) != RESERVA_LIBRE)
+            continue;
+        unsigned generacion = CON_ESTADO(libre + GENERACION_SLOT, 0u);
+        if (atomic_compare_exchange_strong_explicit(&reservas[i].activa, &libre,
+                                                    generacion | RESERVA_PENDIENTE,
+                                                    memory_order_acq_rel,
+                                                    memory_order_relaxed)) {
+            c->proximoSlot = (i + 1) % MAX_RESERVAS;
+            reservas[i].personas = personas;
+            reservas[i].horaInicio = horaInicio;
+            strncpy(reservas[i].familia, familia, MAX_NOMBRE - 1);
+            reservas[i].familia[MAX_NOMBRE - 1] = '\0';
+            *etiqueta = generacion | RESERVA_ACTIVA;
+            atomic_store_explicit(&reservas[i].activa, *etiqueta, memory_order_release);
+            return &reservas[i];
+        }
+    }
+    return NULL;
+}
+
+// Reserva el bloque [hora, hora+2) y lo publica. `horaAct` es la hora con la
+// que se decidio la solicitud: si la tabla esta llena o el reloj avanzo desde
+// entonces, deshace todo antes de retornar.
+static int admitir_optimista(ContadoresHilo *c, const char *familia, int personas, int hora,
+                             int horaAct) {
+    if (!reservar_bloque_optimista(hora, personas))
+        return ADMISION_SIN_CUPO;
+
+    unsigned etiqueta;
+    Reserva *r = publicar_reserva(c, familia, personas, hora, &etiqueta);
+    if (!r) {
+        liberar_horas_optimista(hora, hora + 2, personas);
+        return ADMISION_TABLA_LLENA;
+    }
+
+    // Pareja de la barrera en hilo_reloj: publicar y luego leer la hora. Si
+    // la hora sigue siendo horaAct, el recorrido del proximo tic vera el slot;
+    // si cambio, ese recorrido pudo no verlo, asi que se retira y se reintenta.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&horaActual, memory_order_relaxed) != horaAct) {
+        // Si el CAS falla, el reloj ya mostro y retiro este bloque: queda
+        // contabilizado y se responde como admitido en vez de deshacerlo.
+        unsigned esperada = etiqueta;
+        if (!atomic_compare_exchange_strong_explicit(&r->activa, &esperada,
+                                                     CON_ESTADO(etiqueta, RESERVA_LIBRE),
+                                                     memory_order_acq_rel,
+                                                     memory_order_relaxed))
+            return ADMISION_OK;
+        liberar_horas_optimista(hora, hora + 2, personas);
+        return ADMISION_RELOJ;
+    }
+    return ADMISION_OK;
+}
+
+static void contar(atomic_int *contador) {
+    atomic_fetch_add_explicit(contador, 1, memory_order_relaxed);
+}
+
+// Suma los contadores de los trabajadores y los vuelca, junto con la
+// ocupacion por hora, en `estado` para que el reporte final no dependa del modo.
+static void consolidar_estado_optimista() {
+    estado.solicitudes_aceptadas = 0;
+    estado.solicitudes_reprog = 0;
+    estado.solicitudes_negadas = 0;
+    for (int i = 0; i < numTrabajadores; ++i) {
+        estado.solicitudes_aceptadas += atomic_load_explicit(&contadoresHilo[i].aceptadas,
+                                                             memory_order_relaxed);
+        estado.solicitudes_reprog += atomic_load_explicit(&contadoresHilo[i].reprog,
+                                                          memory_order_relaxed);
+        estado.solicitudes_negadas += atomic_load_explicit(&contadoresHilo[i].negadas,
+                                                           memory_order_relaxed);
+    }
+    for (int h = 0; h <= HORA_MAX; ++h) {
+        estado.horas[h].reservadas = atomic_load(&horasAtomicas[h].reservadas);
+    }
+}
+
+static void procesar_solicitud_optimista(ContadoresHilo *c, const char *pipeResp, char *familia,
+                                         int horaSolic, int personas) {
+    char respuesta[256];
+
+    // Validaciones básicas
+    if (personas > estado.aforo) {
+        contar(&c->negadas);
+        snprintf(respuesta, sizeof(respuesta),
+                 "RESP|NEGADA_AFORO|%s|%d|%d|Personas > aforo",
+                 familia, horaSolic, personas);
+        enviar_respuesta(pipeResp, respuesta);
+        return;
+    }
+
+    if (horaSolic < estado.horaIni || horaSolic > estado.horaFin) {
+        contar(&c->negadas);
+        snprintf(respuesta, sizeof(respuesta),
+                 "RESP|NEGADA_FUERA_RANGO|%s|%d|%d|Hora fuera del rango de simulacion",
+                 familia, horaSolic, personas);
+        enviar_respuesta(pipeResp, respuesta);
+        return;
+    }
+
+    int resultado;
+    int nuevaHora;
+    int extemporanea;
+    do {
+        int horaAct = atomic_load(&horaActual);
+        extemporanea = horaSolic < horaAct;
+
+        if (!extemporanea && horaSolic >= estado.horaFin) {
+            contar(&c->negadas);
+            snprintf(respuesta, sizeof(respuesta),
+                     "RESP|NEGADA_DIA_COMPLETO|%s|%d|%d|Debe volver otro dia",
+                     familia, horaSolic, personas);
+            enviar_respuesta(pipeResp, respuesta);
+            return;
+        }
+
+        resultado = ADMISION_SIN_CUPO;
+        nuevaHora = -1;
+        if (!extemporanea) {
+            resultado = admitir_optimista(c, familia, personas, horaSolic, horaAct);
+            if (resultado == ADMISION_OK) {
+                contar(&c->aceptadas);
+                snprintf(respuesta, sizeof(respuesta),
+                         "RESP|ACEPTADA|%s|%d|%d|Reserva OK %d-%d",
+                         familia, horaSolic, personas, horaSolic, horaSolic + 2);
+                enviar_respuesta(pipeResp, respuesta);
+                return;
+            }
+        }
+
+        // Extemporánea o sin cupo: buscar otra franja
+        for (int h = extemporanea ? horaAct : horaSolic + 1;
+             resultado == ADMISION_SIN_CUPO && h < estado.horaFin; ++h) {
+            resultado = admitir_optimista(c, familia, personas, h, horaAct);
+            if (resultado == ADMISION_OK)
+                nuevaHora = h;
+        }
+    } while (resultado == ADMISION_RELOJ);
+
+    if (resultado == ADMISION_OK) {
+        contar(&c->reprog);
+        snprintf(respuesta, sizeof(respuesta),
+                 "RESP|REPROGRAMADA|%s|%d|%d|Reprogramada a %d-%d",
+                 familia, horaSolic, personas, nuevaHora, nuevaHora + 2);
+    } else if (resultado == ADMISION_TABLA_LLENA) {
+        contar(&c->negadas);
+        snprintf(respuesta, sizeof(respuesta),
+                 "RESP|NEGADA_TABLA_LLENA|%s|%d|%d|Tabla de reservas llena",
+                 familia, horaSolic, personas);
+    } else if (extemporanea) {
+        contar(&c->negadas);
+        snprintf(respuesta, sizeof(respuesta),
+                 "RESP|NEGADA_EXTEMPORANEA|%s|%d|%d|No hay cupo posterior",
+                 familia, horaSolic, personas);
+    } else {
+        contar(&c->negadas);
+        snprintf(respuesta, sizeof(respuesta),
+                 "RESP|NEGADA_SINCUPO|%s|%d|%d|No hay bloques disponibles",
+                 familia, horaSolic, personas);
+    }
+    enviar_respuesta(pipeResp, respuesta);
+}
+
+// ---------------------------------------------------------------------------
+// Cola de solicitudes: el hilo principal lee el pipe y encola; los
+// trabajadores desencolan y admiten en el modo elegido.
+// ---------------------------------------------------------------------------
+
+// Se llama desde el hilo principal, el mismo que procesa los REG, asi que la
+// busqueda del agente y la copia de su pipe no compiten con registrar_agente.
+static void encolar_solicitud(const char *agente, const char *familia, int hora, int personas) {
+    AgenteInfo *info = buscar_agente(agente);
+    if (!info) {
+        fprintf(stderr, "Solicitud de agente no registrado: %s\n", agente);
+        return;
+    }
+
+    pthread_mutex_lock(&lockCola);
+    while (colaLen == MAX_COLA)
+        pthread_cond_wait(&colaNoLlena, &lockCola);
+    Solicitud *s = &cola[(colaIni + colaLen) % MAX_COLA];
+    strncpy(s->pipeRespuesta, info->pipeRespuesta, MAX_PIPE - 1);
+    s->pipeRespuesta[MAX_PIPE - 1] = '\0';
+    strncpy(s->familia, familia, MAX_NOMBRE - 1);
+    s->familia[MAX_NOMBRE - 1] = '\0';
+    s->hora = hora;
+    s->personas = personas;
+    colaLen++;
+    pthread_cond_signal(&colaNoVacia);
+    pthread_mutex_unlock(&lockCola);
+}
+
+// Retorna 0 cuando la cola esta cerrada y vacia.
+static int desencolar_solicitud(Solicitud *s) {
+    pthread_mutex_lock(&lockCola);
+    while (colaLen == 0 && !colaCerrada)
+        pthread_cond_wait(&colaNoVacia, &lockCola);
+    if (colaLen == 0) {
+        pthread_mutex_unlock(&lockCola);
+        return 0;
+    }
+    *s = cola[colaIni];
+    colaIni = (colaIni + 1) % MAX_COLA;
+    colaLen--;
+    pthread_cond_signal(&colaNoLlena);
+    pthread_mutex_unlock(&lockCola);
+    return 1;
+}
+
+static void cerrar_cola() {
+    pthread_mutex_lock(&lockCola);
+    colaCerrada = 1;
+    pthread_cond_broadcast(&colaNoVacia);
+    pthread_mutex_unlock(&lockCola);
+}
+
+// Hilo trabajador de admision. `arg` es su slot de contadores (solo se usa en
+// modo optimista).
+void *hilo_trabajador(void *arg) {
+    ContadoresHilo *c = arg;
+    Solicitud s;
+    while (desencolar_solicitud(&s)) {
+        if (modo == MODO_OPTIMISTA)
+            procesar_solicitud_optimista(c, s.pipeRespuesta, s.familia, s.hora, s.personas);
+        else
+            procesar_solicitud(s.pipeRespuesta, s.familia, s.hora, s.personas);
+    }
+    return NULL;
+}
+
 static void imprimir_movimientos_hora(int hora) {
     // hora es la horaActual después de avanzar
     int entran = 0, salen = 0;
@@ -282,16 +631,23 @@ static void imprimir_movimientos_hora(int hora) {
     printf("** Hora actual: %d:00\n", hora);
     printf("  Familias que salen:\n");
     for (int i = 0; i < MAX_RESERVAS; ++i) {
-        if (reservas[i].activa && reservas[i].horaInicio + 2 == hora) {
+        unsigned etiqueta = leer_slot(i);
+        if (ESTADO_SLOT(etiqueta) == RESERVA_ACTIVA && reservas[i].horaInicio + 2 == hora) {
             printf("    - %s (%d personas)\n", reservas[i].familia, reservas[i].personas);
             salen += reservas[i].personas;
             // la reserva ya terminó completamente
-            reservas[i].activa = 0;
+            if (modo == MODO_OPTIMISTA)
+                atomic_compare_exchange_strong_explicit(&reservas[i].activa, &etiqueta,
+                                                        CON_ESTADO(etiqueta, RESERVA_LIBRE),
+                                                        memory_order_release,
+                                                        memory_order_relaxed);
+            else
+                atomic_store_explicit(&reservas[i].activa, RESERVA_LIBRE, memory_order_relaxed);
         }
     }
     printf("  Familias que entran:\n");
     for (int i = 0; i < MAX_RESERVAS; ++i) {
-        if (reservas[i].activa && reservas[i].horaInicio == hora) {
+        if (reserva_activa(i) && reservas[i].horaInicio == hora) {
             printf("    + %s (%d personas)\n", reservas[i].familia, reservas[i].personas);
             entran += reservas[i].personas;
         }
@@ -306,13 +662,28 @@ void *hilo_reloj(void *arg) {
     while (1) {
         sleep(estado.segHoras);
 
+        if (modo == MODO_OPTIMISTA) {
+            // Solo este hilo escribe horaActual, asi que no hace falta el mutex.
+            // La barrera empareja con la de admitir_optimista: o el trabajador
+            // ve que la hora cambio respecto de la que uso y retira su
+            // reserva, o este recorrido ya ve el slot ACTIVA.
+            int hora = atomic_load(&horaActual);
+            if (hora >= estado.horaFin)
+                break;
+            hora = atomic_fetch_add(&horaActual, 1) + 1;
+            atomic_thread_fence(memory_order_seq_cst);
+            imprimir_movimientos_hora(hora);
+            continue;
+        }
+
         pthread_mutex_lock(&lock);
-        if (horaActual >= estado.horaFin) {
+        int hora = atomic_load_explicit(&horaActual, memory_order_relaxed);
+        if (hora >= estado.horaFin) {
             pthread_mutex_unlock(&lock);
             break;
         }
-        horaActual++;
-        int hora = horaActual;
+        hora++;
+        atomic_store_explicit(&horaActual, hora, memory_order_relaxed);
         imprimir_movimientos_hora(hora);
         pthread_mutex_unlock(&lock);
     }
@@ -349,7 +720,8 @@ static void imprimir_reporte_final() {
 // Parseo de argumentos
 static void uso(const char *prog) {
     fprintf(stderr,
-            "Uso: %s -i horaIni -f horaFin -s segHoras -t aforo -p pipeRecibe\n",
+            "Uso: %s -i horaIni -f horaFin -s segHoras -t aforo -p pipeRecibe"
+            " [-m mutex|optimista] [-w trabajadores]\n",
             prog);
     exit(EXIT_FAILURE);
 }
@@ -359,7 +731,7 @@ int main(int argc, char *argv[]) {
     char pipeRecibe[MAX_PIPE] = {0};
     int tieneI=0,tieneF=0,tieneS=0,tieneT=0,tieneP=0;
 
-    while ((opt = getopt(argc, argv, "i:f:s:t:p:")) != -1) {
+    while ((opt = getopt(argc, argv, "i:f:s:t:p:m:w:")) != -1) {
         switch (opt) {
         case 'i':
             estado.horaIni = atoi(optarg);
@@ -381,6 +753,18 @@ int main(int argc, char *argv[]) {
             strncpy(pipeRecibe, optarg, MAX_PIPE - 1);
             tieneP = 1;
             break;
+        case 'm':
+            if (strcmp(optarg, "mutex") == 0) {
+                modo = MODO_MUTEX;
+            } else if (strcmp(optarg, "optimista") == 0) {
+                modo = MODO_OPTIMISTA;
+            } else {
+                uso(argv[0]);
+            }
+            break;
+        case 'w':
+            numTrabajadores = atoi(optarg);
+            break;
         default:
             uso(argv[0]);
         }
@@ -401,6 +785,10 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "segHoras y aforo deben ser positivos.\n");
         exit(EXIT_FAILURE);
     }
+    if (numTrabajadores < 1 || numTrabajadores > MAX_TRABAJADORES) {
+        fprintf(stderr, "trabajadores debe estar entre 1 y %d.\n", MAX_TRABAJADORES);
+        exit(EXIT_FAILURE);
+    }
 
     inicializar_estado();
 
@@ -415,14 +803,24 @@ int main(int argc, char *argv[]) {
         error_fatal("open pipeRecibe");
     }
 
-    printf("Controlador iniciado. Rango %d-%d, aforo=%d, segHoras=%d, pipe=%s\n",
-           estado.horaIni, estado.horaFin, estado.aforo, estado.segHoras, pipeRecibe);
+    printf("Controlador iniciado. Rango %d-%d, aforo=%d, segHoras=%d, pipe=%s, modo=%s, trabajadores=%d\n",
+           estado.horaIni, estado.horaFin, estado.aforo, estado.segHoras, pipeRecibe,
+           modo == MODO_OPTIMISTA ? "optimista" : "mutex", numTrabajadores);
 
     pthread_t thReloj;
     if (pthread_create(&thReloj, NULL, hilo_reloj, NULL) != 0) {
         error_fatal("pthread_create");
     }
 
+    pthread_t thTrabajadores[MAX_TRABAJADORES];
+    for (int i = 0; i < numTrabajadores; ++i) {
+        // repartir los puntos de partida para que no compitan por los mismos slots
+        contadoresHilo[i].proximoSlot = i * (MAX_RESERVAS / numTrabajadores);
+        if (pthread_create(&thTrabajadores[i], NULL, hilo_trabajador, &contadoresHilo[i]) != 0) {
+            error_fatal("pthread_create");
+        }
+    }
+
     char buffer[MAXLINE];
     while (1) {
         ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
@@ -462,7 +860,7 @@ int main(int argc, char *argv[]) {
                     if (nombreAgente && familia && horaStr && persStr) {
                         int hora = atoi(horaStr);
                         int personas = atoi(persStr);
-                        procesar_solicitud(nombreAgente, familia, hora, personas);
+                        encolar_solicitud(nombreAgente, familia, hora, personas);
                     }
                 }
                 line = strtok(NULL, "\n");
@@ -474,16 +872,28 @@ int main(int argc, char *argv[]) {
             }
         }
 
-        pthread_mutex_lock(&lock);
-        int terminado = (horaActual >= estado.horaFin);
-        pthread_mutex_unlock(&lock);
+        int terminado;
+        if (modo == MODO_OPTIMISTA) {
+            terminado = (atomic_load(&horaActual) >= estado.horaFin);
+        } else {
+            pthread_mutex_lock(&lock);
+            terminado = (atomic_load_explicit(&horaActual, memory_order_relaxed) >= estado.horaFin);
+            pthread_mutex_unlock(&lock);
+        }
         if (terminado) break;
     }
 
+    cerrar_cola();
+    for (int i = 0; i < numTrabajadores; ++i) {
+        pthread_join(thTrabajadores[i], NULL);
+    }
     pthread_join(thReloj, NULL);
     close(fd);
     unlink(pipeRecibe);
 
+    if (modo == MODO_OPTIMISTA) {
+        consolidar_estado_optimista();
+    }
     imprimir_reporte_final();
 
     return 0;